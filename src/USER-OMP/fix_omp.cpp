@@ -333,7 +333,10 @@ void FixOMP::setup(int)
 
 /* ---------------------------------------------------------------------- */
 
-// adjust size and clear out per thread accumulator arrays
+// adjust size and clear out per thread accumulator arrays.
+// the clearing runs inside the parallel region with each thread
+// wiping its own slab, so the slabs beyond the first are first
+// touched - and thus placed - by the thread that will write them.
 void FixOMP::pre_force(int)
 {
   const int nall = atom->nlocal + atom->nghost;
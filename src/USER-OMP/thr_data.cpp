@@ -20,12 +20,53 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "memory.h"
 #include "timer.h"
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
 using namespace LAMMPS_NS;
 
+/* ----------------------------------------------------------------------
+   allocate each per-thread data instance padded and aligned to a full
+   cache line, so that accumulators that are updated concurrently by
+   different threads never share a cache line. otherwise each update
+   would invalidate the corresponding cache line for all other threads.
+------------------------------------------------------------------------- */
+
+void *ThrData::operator new(size_t nbytes)
+{
+  void *ptr;
+
+  // round up to a full multiple of the cache line size, so that
+  // consecutive allocations cannot overlap on the trailing line
+
+  nbytes = ((nbytes + LMP_CACHELINE - 1)/LMP_CACHELINE)*LMP_CACHELINE;
+
+#if defined(_WIN32)
+  ptr = _aligned_malloc(nbytes,LMP_CACHELINE);
+#else
+  int retval = posix_memalign(&ptr,LMP_CACHELINE,nbytes);
+  if (retval) ptr = NULL;
+#endif
+  return ptr;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ThrData::operator delete(void *ptr)
+{
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
 /* ---------------------------------------------------------------------- */
 
 ThrData::ThrData(int tid, Timer *t)
@@ -222,20 +263,34 @@ void ThrData::init_pppm_disp(int order_6, Memory *memory)
    at this point, only pairwise forces have been accumulated in atom->f
 ------------------------------------------------------------------------- */
 
+// the 6 running sums are accumulated into local scalars instead of
+// the virial_pair[] array elements, so that the loops qualify for an
+// 'omp simd' reduction. the pragma needs OpenMP 4.0 (July 2013) and
+// is a no-op for older compilers or builds without (full) OpenMP
+// support, e.g. with only -fopenmp-simd enabled.
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#define LMP_SIMD_FDOTR _Pragma("omp simd reduction(+:v0,v1,v2,v3,v4,v5)")
+#else
+#define LMP_SIMD_FDOTR
+#endif
+
 void ThrData::virial_fdotr_compute(double **x, int nlocal, int nghost, int nfirst)
 {
+  double v0,v1,v2,v3,v4,v5;
+  v0 = v1 = v2 = v3 = v4 = v5 = 0.0;
 
   // sum over force on all particles including ghosts
 
   if (nfirst < 0) {
-    int nall = nlocal + nghost;
+    const int nall = nlocal + nghost;
+    LMP_SIMD_FDOTR
     for (int i = 0; i < nall; i++) {
-      virial_pair[0] += _f[i][0]*x[i][0];
-      virial_pair[1] += _f[i][1]*x[i][1];
-      virial_pair[2] += _f[i][2]*x[i][2];
-      virial_pair[3] += _f[i][1]*x[i][0];
-      virial_pair[4] += _f[i][2]*x[i][0];
-      virial_pair[5] += _f[i][2]*x[i][1];
+      v0 += _f[i][0]*x[i][0];
+      v1 += _f[i][1]*x[i][1];
+      v2 += _f[i][2]*x[i][2];
+      v3 += _f[i][1]*x[i][0];
+      v4 += _f[i][2]*x[i][0];
+      v5 += _f[i][2]*x[i][1];
     }
 
   // neighbor includegroup flag is set
@@ -243,26 +298,37 @@ void ThrData::virial_fdotr_compute(double **x, int nlocal, int nghost, int nfirs
 
   } else {
     int nall = nfirst;
+    LMP_SIMD_FDOTR
     for (int i = 0; i < nall; i++) {
-      virial_pair[0] += _f[i][0]*x[i][0];
-      virial_pair[1] += _f[i][1]*x[i][1];
-      virial_pair[2] += _f[i][2]*x[i][2];
-      virial_pair[3] += _f[i][1]*x[i][0];
-      virial_pair[4] += _f[i][2]*x[i][0];
-      virial_pair[5] += _f[i][2]*x[i][1];
+      v0 += _f[i][0]*x[i][0];
+      v1 += _f[i][1]*x[i][1];
+      v2 += _f[i][2]*x[i][2];
+      v3 += _f[i][1]*x[i][0];
+      v4 += _f[i][2]*x[i][0];
+      v5 += _f[i][2]*x[i][1];
     }
     nall = nlocal + nghost;
+    LMP_SIMD_FDOTR
     for (int i = nlocal; i < nall; i++) {
-      virial_pair[0] += _f[i][0]*x[i][0];
-      virial_pair[1] += _f[i][1]*x[i][1];
-      virial_pair[2] += _f[i][2]*x[i][2];
-      virial_pair[3] += _f[i][1]*x[i][0];
-      virial_pair[4] += _f[i][2]*x[i][0];
-      virial_pair[5] += _f[i][2]*x[i][1];
+      v0 += _f[i][0]*x[i][0];
+      v1 += _f[i][1]*x[i][1];
+      v2 += _f[i][2]*x[i][2];
+      v3 += _f[i][1]*x[i][0];
+      v4 += _f[i][2]*x[i][0];
+      v5 += _f[i][2]*x[i][1];
     }
   }
+
+  virial_pair[0] += v0;
+  virial_pair[1] += v1;
+  virial_pair[2] += v2;
+  virial_pair[3] += v3;
+  virial_pair[4] += v4;
+  virial_pair[5] += v5;
 }
 
+#undef LMP_SIMD_FDOTR
+
 /* ---------------------------------------------------------------------- */
 
 double ThrData::memory_usage()
@@ -282,16 +348,30 @@ double ThrData::memory_usage()
 // multi-dimensional arrays like force stored in this order
 // x1,y1,z1,x2,y2,z2,...
 // we need to post a barrier to wait until all threads are done
-// with writing to the array .
-void LAMMPS_NS::data_reduce_thr(double *dall, int nall, int nthreads, int ndim, int tid)
+// with writing to the array. when the caller has already posted
+// a barrier after the last write, it can pass dosync=0 to skip
+// the redundant synchronization.
+// the reduction is parallelized over the target index range, not
+// over threads: each thread sums the contributions of all nthreads
+// slabs for its own slice of the flat array, so all cores take part
+// and each target element is written exactly once. this makes the
+// operation bandwidth bound at the aggregate rate of all cores
+// instead of being serialized on one of them.
+void LAMMPS_NS::data_reduce_thr(double *dall, int nall, int nthreads, int ndim,
+                                int tid, int dosync)
 {
 #if defined(_OPENMP)
   // NOOP in single-threaded execution.
   if (nthreads == 1) return;
+  if (dosync) {
 #pragma omp barrier
+  }
   {
     const int nvals = ndim*nall;
-    const int idelta = nvals/nthreads + 1;
+    // round the chunk size up to a multiple of 8 doubles, i.e. one
+    // 64-byte cache line, so that chunks assigned to different
+    // threads never share a cache line at their boundaries.
+    const int idelta = ((nvals/nthreads + 1) + 7) & ~7;
     const int ifrom = tid*idelta;
     const int ito   = ((ifrom + idelta) > nvals) ? nvals : (ifrom + idelta);
 
@@ -300,6 +380,48 @@ void LAMMPS_NS::data_reduce_thr(double *dall, int nall, int nthreads, int ndim,
       int m = 0;
 
       for (m = ifrom; m < ito; ++m) {
+        for (int n = 1; n < nthreads; ++n) {
+          double * _noalias const dslab = dall + n*nvals;
+          dall[m] += dslab[m];
+          dslab[m] = 0.0;
+        }
+      }
+    }
+#elif defined(__AVX__)
+    // since the array is reduced as one flat stream of values, a full
+    // 64-byte cache line can be processed as two 4-wide vector adds
+    // per iteration, no matter how many values there are per atom.
+    // this halves the instruction count of the scalar unrolled loop
+    // below. this if protects against having more threads than atoms.
+    if (ifrom < nvals) {
+      int m = 0;
+      const __m256d zero = _mm256_setzero_pd();
+
+      for (m = ifrom; m < (ito-7); m+=8) {
+        double * _noalias const dst = dall + m;
+        __m256d t0 = _mm256_loadu_pd(dst  );
+        __m256d t1 = _mm256_loadu_pd(dst+4);
+        for (int n = 1; n < nthreads; ++n) {
+          // cache the slab address, so the inner loads/stores become
+          // plain pointer arithmetic instead of an indexed rescale
+          double * _noalias const src = dall + n*nvals + m;
+#if defined(__GNUC__)
+          // the reduction advances nthreads widely separated streams
+          // in lockstep, which can exhaust the stream tracking of the
+          // hardware prefetcher. fetch the next line of this slab by
+          // hand; it will be both read and overwritten with zeros.
+          __builtin_prefetch(src + 8, 1, 0);
+#endif
+          t0 = _mm256_add_pd(t0,_mm256_loadu_pd(src  ));
+          t1 = _mm256_add_pd(t1,_mm256_loadu_pd(src+4));
+          _mm256_storeu_pd(src  ,zero);
+          _mm256_storeu_pd(src+4,zero);
+        }
+        _mm256_storeu_pd(dst  ,t0);
+        _mm256_storeu_pd(dst+4,t1);
+      }
+      // do the last < 8 values
+      for (; m < ito; m++) {
         for (int n = 1; n < nthreads; ++n) {
           dall[m] += dall[n*nvals + m];
           dall[n*nvals + m] = 0.0;
@@ -317,40 +439,51 @@ void LAMMPS_NS::data_reduce_thr(double *dall, int nall, int nthreads, int ndim,
       // -- modify this code based on the size of the cache line
       double t0, t1, t2, t3, t4, t5, t6, t7;
       for (m = ifrom; m < (ito-7); m+=8) {
-        t0 = dall[m  ];
-        t1 = dall[m+1];
-        t2 = dall[m+2];
-        t3 = dall[m+3];
-        t4 = dall[m+4];
-        t5 = dall[m+5];
-        t6 = dall[m+6];
-        t7 = dall[m+7];
+        double * _noalias const dst = dall + m;
+        t0 = dst[0];
+        t1 = dst[1];
+        t2 = dst[2];
+        t3 = dst[3];
+        t4 = dst[4];
+        t5 = dst[5];
+        t6 = dst[6];
+        t7 = dst[7];
         for (int n = 1; n < nthreads; ++n) {
-          t0 += dall[n*nvals + m  ];
-          t1 += dall[n*nvals + m+1];
-          t2 += dall[n*nvals + m+2];
-          t3 += dall[n*nvals + m+3];
-          t4 += dall[n*nvals + m+4];
-          t5 += dall[n*nvals + m+5];
-          t6 += dall[n*nvals + m+6];
-          t7 += dall[n*nvals + m+7];
-          dall[n*nvals + m  ] = 0.0;
-          dall[n*nvals + m+1] = 0.0;
-          dall[n*nvals + m+2] = 0.0;
-          dall[n*nvals + m+3] = 0.0;
-          dall[n*nvals + m+4] = 0.0;
-          dall[n*nvals + m+5] = 0.0;
-          dall[n*nvals + m+6] = 0.0;
-          dall[n*nvals + m+7] = 0.0;
+          // cache the slab address, so the inner loads/stores become
+          // plain pointer arithmetic instead of an indexed rescale
+          double * _noalias const src = dall + n*nvals + m;
+#if defined(__GNUC__)
+          // the reduction advances nthreads widely separated streams
+          // in lockstep, which can exhaust the stream tracking of the
+          // hardware prefetcher. fetch the next line of this slab by
+          // hand; it will be both read and overwritten with zeros.
+          __builtin_prefetch(src + 8, 1, 0);
+#endif
+          t0 += src[0];
+          t1 += src[1];
+          t2 += src[2];
+          t3 += src[3];
+          t4 += src[4];
+          t5 += src[5];
+          t6 += src[6];
+          t7 += src[7];
+          src[0] = 0.0;
+          src[1] = 0.0;
+          src[2] = 0.0;
+          src[3] = 0.0;
+          src[4] = 0.0;
+          src[5] = 0.0;
+          src[6] = 0.0;
+          src[7] = 0.0;
         }
-        dall[m  ] = t0;
-        dall[m+1] = t1;
-        dall[m+2] = t2;
-        dall[m+3] = t3;
-        dall[m+4] = t4;
-        dall[m+5] = t5;
-        dall[m+6] = t6;
-        dall[m+7] = t7;
+        dst[0] = t0;
+        dst[1] = t1;
+        dst[2] = t2;
+        dst[3] = t3;
+        dst[4] = t4;
+        dst[5] = t5;
+        dst[6] = t6;
+        dst[7] = t7;
       }
       // do the last < 8 values
       for (; m < ito; m++) {
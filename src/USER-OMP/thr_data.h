@@ -24,6 +24,17 @@
 
 #include "timer.h"
 
+// size of an L1 D-cache line in bytes. per-thread accumulator storage
+// is padded and aligned to this size, so that accumulators updated
+// concurrently by different threads never share a cache line.
+#if !defined(LMP_CACHELINE)
+#if defined(__powerpc__) || defined(_ARCH_PPC)
+#define LMP_CACHELINE 128
+#else
+#define LMP_CACHELINE 64
+#endif
+#endif
+
 namespace LAMMPS_NS {
 
 // per thread data accumulators
@@ -37,6 +48,10 @@ class ThrData {
   ThrData(int tid, class Timer *t);
   ~ThrData() { delete _timer; _timer = NULL; };
 
+  // allocate instances aligned to cache line boundaries
+  void *operator new(size_t);
+  void operator delete(void *);
+
   void check_tid(int);    // thread id consistency check
   int get_tid() const { return _tid; }; // our thread id.
 
@@ -146,7 +161,10 @@ class ThrData {
 ////////////////////////////////////////////////////////////////////////
 //  helper functions operating on data replicated for thread support  //
 ////////////////////////////////////////////////////////////////////////
-// generic per thread data reduction for continous arrays of nthreads*nmax size
-void data_reduce_thr(double *, int, int, int, int);
+// generic per thread data reduction for continous arrays of nthreads*nmax size.
+// the barrier waiting for all threads to be done writing to the array may be
+// suppressed with dosync=0, if the caller has already posted a barrier after
+// the last write. this saves one thread synchronization per call.
+void data_reduce_thr(double *, int, int, int, int, int dosync=1);
 }
 #endif
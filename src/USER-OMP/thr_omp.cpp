@@ -63,6 +63,11 @@ ThrOMP::~ThrOMP()
 
 /* ----------------------------------------------------------------------
    Hook up per thread per atom arrays into the tally infrastructure
+   This is called from inside the parallel region, so each thread
+   clears its own slab of the shared arrays with memset. Apart from
+   running the zeroing at full aggregate memory bandwidth, this also
+   makes each thread first-touch the pages it will later write to in
+   the tally calls, which places them on its local NUMA node.
    ---------------------------------------------------------------------- */
 
 void ThrOMP::ev_setup_thr(int eflag, int vflag, int nall, double *eatom,
@@ -164,6 +169,8 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
 
   int need_force_reduce = 1;
 
+  // posting this barrier once here makes all tally writes visible,
+  // so the individual reductions below can skip their own barriers.
   if (evflag)
     sync_threads();
 
@@ -184,7 +191,7 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
         if (style == fix->last_pair_hybrid) {
           // pair_style hybrid will compute fdotr for us
           // but we first need to reduce the forces
-          data_reduce_thr(&(f[0][0]), nall, nthreads, 3, tid);
+          data_reduce_thr(&(f[0][0]), nall, nthreads, 3, tid, 0);
           fix->did_reduce();
           need_force_reduce = 0;
         }
@@ -210,10 +217,10 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(pair->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(pair->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(pair->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(pair->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
     }
   }
@@ -241,10 +248,10 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(bond->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(bond->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(bond->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(bond->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
 
     }
@@ -272,10 +279,10 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(angle->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(angle->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(angle->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(angle->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
 
     }
@@ -303,10 +310,10 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(dihedral->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(dihedral->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(dihedral->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(dihedral->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
 
     }
@@ -341,12 +348,12 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(dihedral->eatom[0]), nall, nthreads, 1, tid);
-        data_reduce_thr(&(pair->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(dihedral->eatom[0]), nall, nthreads, 1, tid, 0);
+        data_reduce_thr(&(pair->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(dihedral->vatom[0][0]), nall, nthreads, 6, tid);
-        data_reduce_thr(&(pair->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(dihedral->vatom[0][0]), nall, nthreads, 6, tid, 0);
+        data_reduce_thr(&(pair->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
     }
     break;
@@ -373,10 +380,10 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
       }
 
       if (eflag & 2) {
-        data_reduce_thr(&(improper->eatom[0]), nall, nthreads, 1, tid);
+        data_reduce_thr(&(improper->eatom[0]), nall, nthreads, 1, tid, 0);
       }
       if (vflag & 4) {
-        data_reduce_thr(&(improper->vatom[0][0]), nall, nthreads, 6, tid);
+        data_reduce_thr(&(improper->vatom[0][0]), nall, nthreads, 6, tid, 0);
       }
 
     }
@@ -391,169 +398,43 @@ void ThrOMP::reduce_thr(void *style, const int eflag, const int vflag,
     break;
 
   default:
-    printf("tid:%d unhandled thr_style case %d\n", tid, thr_style);
+    fprintf(stderr,"WARNING: unhandled thr_style %d in reduce_thr (tid:%d)\n",
+            thr_style, tid);
     break;
   }
 
   if (style == fix->last_omp_style) {
     if (need_force_reduce) {
-      data_reduce_thr(&(f[0][0]), nall, nthreads, 3, tid);
+      // without tallying no barrier has been posted yet in this call
+      data_reduce_thr(&(f[0][0]), nall, nthreads, 3, tid, evflag ? 0 : 1);
       fix->did_reduce();
     }
 
     if (lmp->atom->torque)
-      data_reduce_thr(&(lmp->atom->torque[0][0]), nall, nthreads, 3, tid);
+      data_reduce_thr(&(lmp->atom->torque[0][0]), nall, nthreads, 3, tid, 0);
   }
   thr->timer(Timer::COMM);
 }
 
 /* ----------------------------------------------------------------------
-   tally eng_vdwl and eng_coul into per thread global and per-atom accumulators
+   run ev_tally callbacks for pair styles. the callbacks are not thread
+   safe and thus have to be protected. this is rarely used functionality
+   and thus kept out of the inlined hot path in the header.
 ------------------------------------------------------------------------- */
 
-void ThrOMP::e_tally_thr(Pair * const pair, const int i, const int j,
-                         const int nlocal, const int newton_pair,
-                         const double evdwl, const double ecoul, ThrData * const thr)
+void ThrOMP::ev_tally_callback_thr(Pair * const pair, const int i, const int j,
+                                   const int nlocal, const int newton_pair,
+                                   const double evdwl, const double ecoul,
+                                   const double fpair, const double delx,
+                                   const double dely, const double delz)
 {
-  if (pair->eflag_global) {
-    if (newton_pair) {
-      thr->eng_vdwl += evdwl;
-      thr->eng_coul += ecoul;
-    } else {
-      const double evdwlhalf = 0.5*evdwl;
-      const double ecoulhalf = 0.5*ecoul;
-      if (i < nlocal) {
-        thr->eng_vdwl += evdwlhalf;
-        thr->eng_coul += ecoulhalf;
-      }
-      if (j < nlocal) {
-        thr->eng_vdwl += evdwlhalf;
-        thr->eng_coul += ecoulhalf;
-      }
-    }
-  }
-  if (pair->eflag_atom) {
-    const double epairhalf = 0.5 * (evdwl + ecoul);
-    if (newton_pair || i < nlocal) thr->eatom_pair[i] += epairhalf;
-    if (newton_pair || j < nlocal) thr->eatom_pair[j] += epairhalf;
-  }
-}
-
-/* helper functions */
-static void v_tally(double * const vout, const double * const vin)
-{
-  vout[0] += vin[0];
-  vout[1] += vin[1];
-  vout[2] += vin[2];
-  vout[3] += vin[3];
-  vout[4] += vin[4];
-  vout[5] += vin[5];
-}
-
-static void v_tally(double * const vout, const double scale, const double * const vin)
-{
-  vout[0] += scale*vin[0];
-  vout[1] += scale*vin[1];
-  vout[2] += scale*vin[2];
-  vout[3] += scale*vin[3];
-  vout[4] += scale*vin[4];
-  vout[5] += scale*vin[5];
-}
-
-/* ----------------------------------------------------------------------
-   tally virial into per thread global and per-atom accumulators
-------------------------------------------------------------------------- */
-void ThrOMP::v_tally_thr(Pair * const pair, const int i, const int j,
-                         const int nlocal, const int newton_pair,
-                         const double * const v, ThrData * const thr)
-{
-  if (pair->vflag_global) {
-    double * const va = thr->virial_pair;
-    if (newton_pair) {
-      v_tally(va,v);
-    } else {
-      if (i < nlocal) v_tally(va,0.5,v);
-      if (j < nlocal) v_tally(va,0.5,v);
-    }
-  }
-
-  if (pair->vflag_atom) {
-    if (newton_pair || i < nlocal) {
-      double * const va = thr->vatom_pair[i];
-      v_tally(va,0.5,v);
-    }
-    if (newton_pair || j < nlocal) {
-      double * const va = thr->vatom_pair[j];
-      v_tally(va,0.5,v);
-    }
-  }
-}
-
-/* ----------------------------------------------------------------------
-   tally eng_vdwl and virial into per thread global and per-atom accumulators
-   need i < nlocal test since called by bond_quartic and dihedral_charmm
-------------------------------------------------------------------------- */
-
-void ThrOMP::ev_tally_thr(Pair * const pair, const int i, const int j, const int nlocal,
-                          const int newton_pair, const double evdwl, const double ecoul,
-                          const double fpair, const double delx, const double dely,
-                          const double delz, ThrData * const thr)
-{
-
-  if (pair->eflag_either)
-    e_tally_thr(pair, i, j, nlocal, newton_pair, evdwl, ecoul, thr);
-
-  if (pair->vflag_either) {
-    double v[6];
-    v[0] = delx*delx*fpair;
-    v[1] = dely*dely*fpair;
-    v[2] = delz*delz*fpair;
-    v[3] = delx*dely*fpair;
-    v[4] = delx*delz*fpair;
-    v[5] = dely*delz*fpair;
-
-    v_tally_thr(pair, i, j, nlocal, newton_pair, v, thr);
-  }
-
-  if (pair->num_tally_compute > 0) {
-    // ev_tally callbacks are not thread safe and thus have to be protected
 #if defined(_OPENMP)
 #pragma omp critical
 #endif
-    for (int k=0; k < pair->num_tally_compute; ++k) {
-      Compute *c = pair->list_tally_compute[k];
-      c->pair_tally_callback(i, j, nlocal, newton_pair,
-                             evdwl, ecoul, fpair, delx, dely, delz);
-    }
-  }
-}
-
-/* ----------------------------------------------------------------------
-   tally eng_vdwl and virial into global and per-atom accumulators
-   for virial, have delx,dely,delz and fx,fy,fz
-------------------------------------------------------------------------- */
-
-void ThrOMP::ev_tally_xyz_thr(Pair * const pair, const int i, const int j,
-                              const int nlocal, const int newton_pair,
-                              const double evdwl, const double ecoul,
-                              const double fx, const double fy, const double fz,
-                              const double delx, const double dely, const double delz,
-                              ThrData * const thr)
-{
-
-  if (pair->eflag_either)
-    e_tally_thr(pair, i, j, nlocal, newton_pair, evdwl, ecoul, thr);
-
-  if (pair->vflag_either) {
-    double v[6];
-    v[0] = delx*fx;
-    v[1] = dely*fy;
-    v[2] = delz*fz;
-    v[3] = delx*fy;
-    v[4] = delx*fz;
-    v[5] = dely*fz;
-
-    v_tally_thr(pair, i, j, nlocal, newton_pair, v, thr);
+  for (int k=0; k < pair->num_tally_compute; ++k) {
+    Compute *c = pair->list_tally_compute[k];
+    c->pair_tally_callback(i, j, nlocal, newton_pair,
+                           evdwl, ecoul, fpair, delx, dely, delz);
   }
 }
 
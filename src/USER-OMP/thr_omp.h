@@ -22,6 +22,11 @@
 #include "error.h"
 #include "fix_omp.h"
 #include "thr_data.h"
+#include "pair.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
 
 namespace LAMMPS_NS {
 
@@ -114,6 +119,10 @@ class ThrOMP {
   void ev_tally_thr(Pair * const, const int, const int, const int, const int,
                     const double, const double, const double, const double,
                     const double, const double, ThrData * const);
+  void ev_tally_callback_thr(Pair * const, const int, const int, const int,
+                             const int, const double, const double,
+                             const double, const double, const double,
+                             const double);
   void ev_tally_xyz_thr(Pair * const, const int, const int, const int,
                         const int, const double, const double, const double,
                         const double, const double, const double,
@@ -167,6 +176,182 @@ class ThrOMP {
 
 };
 
+/* ----------------------------------------------------------------------
+   the pairwise tally functions and their helpers below are defined
+   inline in this header, so that the compiler can fuse them into the
+   templated force kernels of the /omp pair styles. this keeps the
+   delx/dely/delz/fpair quantities in registers instead of spilling
+   them across a function call for every tallied interaction, and
+   allows hoisting the loop invariant tally flag tests.
+------------------------------------------------------------------------- */
+
+/* helper functions */
+#if defined(__AVX__)
+
+// vectorized versions of the 6-component virial accumulation.
+// process the first 4 components in one 256-bit register and the
+// remaining 2 components in one 128-bit register. this halves the
+// number of retired instructions on one of the most frequently
+// executed code paths in the tally infrastructure. unaligned
+// loads/stores are used, since neither the per-atom virial rows
+// nor the v[6] buffers on the stack have guaranteed alignment.
+
+static inline void v_tally(double * _noalias const vout,
+                           const double * _noalias const vin)
+{
+  _mm256_storeu_pd(vout,_mm256_add_pd(_mm256_loadu_pd(vout),
+                                      _mm256_loadu_pd(vin)));
+  _mm_storeu_pd(vout+4,_mm_add_pd(_mm_loadu_pd(vout+4),
+                                  _mm_loadu_pd(vin+4)));
+}
+
+static inline void v_tally(double * _noalias const vout, const double scale,
+                           const double * _noalias const vin)
+{
+  const __m256d s4 = _mm256_set1_pd(scale);
+  _mm256_storeu_pd(vout,_mm256_add_pd(_mm256_loadu_pd(vout),
+                                      _mm256_mul_pd(s4,_mm256_loadu_pd(vin))));
+  _mm_storeu_pd(vout+4,_mm_add_pd(_mm_loadu_pd(vout+4),
+                                  _mm_mul_pd(_mm256_castpd256_pd128(s4),
+                                             _mm_loadu_pd(vin+4))));
+}
+
+#else
+
+static inline void v_tally(double * _noalias const vout,
+                           const double * _noalias const vin)
+{
+  vout[0] += vin[0];
+  vout[1] += vin[1];
+  vout[2] += vin[2];
+  vout[3] += vin[3];
+  vout[4] += vin[4];
+  vout[5] += vin[5];
+}
+
+static inline void v_tally(double * _noalias const vout, const double scale,
+                           const double * _noalias const vin)
+{
+  vout[0] += scale*vin[0];
+  vout[1] += scale*vin[1];
+  vout[2] += scale*vin[2];
+  vout[3] += scale*vin[3];
+  vout[4] += scale*vin[4];
+  vout[5] += scale*vin[5];
+}
+
+#endif
+
+
+/* ----------------------------------------------------------------------
+   tally eng_vdwl and eng_coul into per thread global and per-atom accumulators
+------------------------------------------------------------------------- */
+
+inline void ThrOMP::e_tally_thr(Pair * const pair, const int i, const int j,
+                         const int nlocal, const int newton_pair,
+                         const double evdwl, const double ecoul, ThrData * const thr)
+{
+  // fold the newton/ghost branch cascade into 0.0/0.5 weights, so the
+  // tally becomes straight-line arithmetic. for pairs straddling the
+  // ghost atom boundary these branches are poorly predictable, and
+  // adding a zero contribution is always safe since ghost atoms have
+  // valid entries in the per-atom accumulators.
+  const double wi = (newton_pair || i < nlocal) ? 0.5 : 0.0;
+  const double wj = (newton_pair || j < nlocal) ? 0.5 : 0.0;
+
+  if (pair->eflag_global) {
+    thr->eng_vdwl += (wi+wj)*evdwl;
+    thr->eng_coul += (wi+wj)*ecoul;
+  }
+  if (pair->eflag_atom) {
+    // cache the slab pointer with the no-aliasing attribute, so the
+    // two updates may be scheduled independently of the loads above
+    double * _noalias const eatom = thr->eatom_pair;
+    const double epair = evdwl + ecoul;
+    eatom[i] += wi*epair;
+    eatom[j] += wj*epair;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   tally virial into per thread global and per-atom accumulators
+------------------------------------------------------------------------- */
+inline void ThrOMP::v_tally_thr(Pair * const pair, const int i, const int j,
+                         const int nlocal, const int newton_pair,
+                         const double * const v, ThrData * const thr)
+{
+  // same branchless weighting as in e_tally_thr.
+  const double wi = (newton_pair || i < nlocal) ? 0.5 : 0.0;
+  const double wj = (newton_pair || j < nlocal) ? 0.5 : 0.0;
+
+  if (pair->vflag_global) v_tally(thr->virial_pair,wi+wj,v);
+
+  if (pair->vflag_atom) {
+    v_tally(thr->vatom_pair[i],wi,v);
+    v_tally(thr->vatom_pair[j],wj,v);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   tally eng_vdwl and virial into per thread global and per-atom accumulators
+   need i < nlocal test since called by bond_quartic and dihedral_charmm
+------------------------------------------------------------------------- */
+
+inline void ThrOMP::ev_tally_thr(Pair * const pair, const int i, const int j, const int nlocal,
+                          const int newton_pair, const double evdwl, const double ecoul,
+                          const double fpair, const double delx, const double dely,
+                          const double delz, ThrData * const thr)
+{
+
+  if (pair->eflag_either)
+    e_tally_thr(pair, i, j, nlocal, newton_pair, evdwl, ecoul, thr);
+
+  if (pair->vflag_either) {
+    double v[6];
+    v[0] = delx*delx*fpair;
+    v[1] = dely*dely*fpair;
+    v[2] = delz*delz*fpair;
+    v[3] = delx*dely*fpair;
+    v[4] = delx*delz*fpair;
+    v[5] = dely*delz*fpair;
+
+    v_tally_thr(pair, i, j, nlocal, newton_pair, v, thr);
+  }
+
+  if (pair->num_tally_compute > 0)
+    ev_tally_callback_thr(pair, i, j, nlocal, newton_pair,
+                          evdwl, ecoul, fpair, delx, dely, delz);
+}
+
+/* ----------------------------------------------------------------------
+   tally eng_vdwl and virial into global and per-atom accumulators
+   for virial, have delx,dely,delz and fx,fy,fz
+------------------------------------------------------------------------- */
+
+inline void ThrOMP::ev_tally_xyz_thr(Pair * const pair, const int i, const int j,
+                              const int nlocal, const int newton_pair,
+                              const double evdwl, const double ecoul,
+                              const double fx, const double fy, const double fz,
+                              const double delx, const double dely, const double delz,
+                              ThrData * const thr)
+{
+
+  if (pair->eflag_either)
+    e_tally_thr(pair, i, j, nlocal, newton_pair, evdwl, ecoul, thr);
+
+  if (pair->vflag_either) {
+    double v[6];
+    v[0] = delx*fx;
+    v[1] = dely*fy;
+    v[2] = delz*fz;
+    v[3] = delx*fy;
+    v[4] = delx*fz;
+    v[5] = dely*fz;
+
+    v_tally_thr(pair, i, j, nlocal, newton_pair, v, thr);
+  }
+}
+
 // set loop range thread id, and force array offset for threaded runs.
 static inline void loop_setup_thr(int &ifrom, int &ito, int &tid,
                                   int inum, int nthreads)
@@ -174,10 +359,13 @@ static inline void loop_setup_thr(int &ifrom, int &ito, int &tid,
 #if defined(_OPENMP)
   tid = omp_get_thread_num();
 
-  // each thread works on a fixed chunk of atoms.
-  const int idelta = 1 + inum/nthreads;
-  ifrom = tid*idelta;
-  ito   = ((ifrom + idelta) > inum) ? inum : ifrom + idelta;
+  // each thread works on a fixed contiguous chunk of atoms, so that
+  // per-thread data stays on the pages the thread first touched.
+  // the remainder of inum/nthreads is spread across the threads
+  // instead of being taken out of the last thread's chunk, which
+  // would leave it with up to nthreads-1 fewer atoms than the rest.
+  ifrom = static_cast<int>(static_cast<bigint>(tid)*inum/nthreads);
+  ito   = static_cast<int>(static_cast<bigint>(tid+1)*inum/nthreads);
 #else
   tid = 0;
   ifrom = 0;